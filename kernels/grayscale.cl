@@ -1,3 +1,6 @@
+// Keep multiply and add rounded separately: fused FMA changes results on some devices
+#pragma OPENCL FP_CONTRACT OFF
+
 __kernel void grayscale(__global const uchar4 *input, __global uchar4 *output, uint in_width, uint out_width,
                         uint out_height) {
     int x = get_global_id(0);
@@ -0,0 +1,384 @@
+#include <gtest/gtest.h>
+
+#include "opencl_manager.hpp"
+#include "processors/crop_processor.hpp"
+#include "processors/grayscale_processor.hpp"
+#include "processors/halftone_processor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+// Regression suite: every processor and the crop -> grayscale -> halftone pipeline are run on the
+// committed resources and on large tiled copies of them. Outputs must match the golden images
+// bit-exactly, and the large cases must keep their throughput within REGRESSION_TOLERANCE of the
+// baseline stored in REGRESSION_BASELINE_FILE. The baseline is only written with
+// REGRESSION_UPDATE_BASELINE=1; without a usable baseline the timing check is skipped, or fails
+// with REGRESSION_STRICT=1.
+
+#ifndef REGRESSION_DEFAULT_BASELINE_FILE
+#define REGRESSION_DEFAULT_BASELINE_FILE ""
+#endif
+
+#ifndef REGRESSION_DEFAULT_TOLERANCE
+#define REGRESSION_DEFAULT_TOLERANCE "0.15"
+#endif
+
+namespace {
+
+struct Image {
+    std::vector<cl_uchar4> pixels;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Crop region used by main.cpp to produce resources/cropped.png
+const uint32_t kCropSize = 170;
+const uint32_t kCropX = 232;
+const uint32_t kCropY = 316;
+
+std::string envOr(const char *name, const std::string &fallback) {
+    const char *value = std::getenv(name);
+    return value && *value ? std::string(value) : fallback;
+}
+
+// Parses a numeric environment variable, rejecting values with trailing garbage
+template <typename T>
+T envNumber(const char *name, const std::string &fallback, T (*parse)(const std::string &, size_t *)) {
+    std::string value = envOr(name, fallback);
+    size_t parsed = 0;
+    T result{};
+    try {
+        result = parse(value, &parsed);
+    } catch (const std::exception &) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != value.size()) {
+        throw std::runtime_error(std::string(name) + " is not a valid number: '" + value + "'");
+    }
+    return result;
+}
+
+double parseDouble(const std::string &value, size_t *parsed) {
+    return std::stod(value, parsed);
+}
+
+long long parseInteger(const std::string &value, size_t *parsed) {
+    return std::stoll(value, parsed);
+}
+
+Image loadImage(const std::string &file_name) {
+    auto [width, height] = getImageSize(file_name);
+    return { readImageArray(file_name), width, height };
+}
+
+// Repeats the image tiles_x times horizontally and tiles_y times vertically. All kernels are
+// per-pixel, so processing a tiled input must give exactly the tiled golden output.
+Image tileImage(const Image &image, uint32_t tiles_x, uint32_t tiles_y) {
+    Image tiled{ {}, image.width * tiles_x, image.height * tiles_y };
+    tiled.pixels.resize(static_cast<size_t>(tiled.width) * tiled.height);
+    for (uint32_t y = 0; y < tiled.height; ++y) {
+        const cl_uchar4 *row = image.pixels.data() + static_cast<size_t>(y % image.height) * image.width;
+        cl_uchar4 *out = tiled.pixels.data() + static_cast<size_t>(y) * tiled.width;
+        for (uint32_t tx = 0; tx < tiles_x; ++tx) {
+            std::copy(row, row + image.width, out + static_cast<size_t>(tx) * image.width);
+        }
+    }
+    return tiled;
+}
+
+void expectImagesEqual(const Image &actual, const Image &golden, const std::string &name) {
+    ASSERT_EQ(actual.width, golden.width) << name << ": width mismatch";
+    ASSERT_EQ(actual.height, golden.height) << name << ": height mismatch";
+    ASSERT_EQ(actual.pixels.size(), golden.pixels.size()) << name << ": output array size mismatch";
+
+    size_t mismatches = 0;
+    size_t first = 0;
+    for (size_t i = 0; i < golden.pixels.size(); ++i) {
+        const cl_uchar4 &a = actual.pixels[i];
+        const cl_uchar4 &g = golden.pixels[i];
+        if (a.s[0] != g.s[0] || a.s[1] != g.s[1] || a.s[2] != g.s[2] || a.s[3] != g.s[3]) {
+            if (mismatches++ == 0) {
+                first = i;
+            }
+        }
+    }
+    if (mismatches != 0) {
+        const cl_uchar4 &a = actual.pixels[first];
+        const cl_uchar4 &g = golden.pixels[first];
+        ADD_FAILURE() << name << ": " << mismatches << " pixels differ from golden, first at ("
+                      << first % golden.width << "," << first / golden.width << "): got (" << (int) a.s[0] << ","
+                      << (int) a.s[1] << "," << (int) a.s[2] << "," << (int) a.s[3] << "), expected ("
+                      << (int) g.s[0] << "," << (int) g.s[1] << "," << (int) g.s[2] << "," << (int) g.s[3] << ")";
+    }
+}
+
+// Baseline file format: a "# device: <name>" header followed by "<case> <megapixels/s>" lines
+class ThroughputBaseline {
+  public:
+    ThroughputBaseline(const std::string &path, const std::string &device) : path(path), device(device) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return;
+        }
+        loaded = true;
+        std::string line;
+        const std::string header = "# device: ";
+        while (std::getline(file, line)) {
+            if (line.compare(0, header.size(), header) == 0) {
+                stored_device = line.substr(header.size());
+                continue;
+            }
+            std::istringstream fields(line);
+            std::string name;
+            double value;
+            if (fields >> name >> value) {
+                entries[name] = value;
+            }
+        }
+    }
+
+    const std::string &getPath() const {
+        return path;
+    }
+
+    bool isLoaded() const {
+        return loaded;
+    }
+
+    const std::string &getStoredDevice() const {
+        return stored_device;
+    }
+
+    bool matchesDevice() const {
+        return stored_device == device;
+    }
+
+    bool has(const std::string &name) const {
+        return entries.count(name) != 0;
+    }
+
+    double get(const std::string &name) const {
+        return entries.at(name);
+    }
+
+    // Records a new value for this device; entries from another device are dropped
+    void set(const std::string &name, double value) {
+        if (!matchesDevice()) {
+            entries.clear();
+            stored_device = device;
+        }
+        loaded = true;
+        entries[name] = value;
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to write throughput baseline: " + path);
+        }
+        file << "# device: " << device << "\n";
+        for (const auto &[key, mpix_per_s] : entries) {
+            file << key << " " << mpix_per_s << "\n";
+        }
+    }
+
+  private:
+    std::string path;
+    std::string device;
+    std::string stored_device;
+    bool loaded = false;
+    std::map<std::string, double> entries;
+};
+
+} // namespace
+
+class RegressionTest : public ::testing::Test {
+  protected:
+    static void SetUpTestSuite() {
+        manager = std::make_unique<OpenCLManager>();
+        cropper = std::make_unique<CropProcessor>(*manager);
+        grayscaler = std::make_unique<GrayscaleProcessor>(*manager);
+        halftoner = std::make_unique<HalftoneProcessor>(*manager);
+
+        std::string device = manager->getDevice().getInfo<CL_DEVICE_NAME>();
+        device.erase(std::find(device.begin(), device.end(), '\0'), device.end());
+        std::string baseline_file = envOr("REGRESSION_BASELINE_FILE", REGRESSION_DEFAULT_BASELINE_FILE);
+        if (baseline_file.empty()) {
+            throw std::runtime_error("REGRESSION_BASELINE_FILE must be set");
+        }
+        baseline = std::make_unique<ThroughputBaseline>(baseline_file, device);
+
+        tolerance = envNumber("REGRESSION_TOLERANCE", REGRESSION_DEFAULT_TOLERANCE, parseDouble);
+        if (!(tolerance >= 0.0 && tolerance < 1.0)) {
+            throw std::runtime_error("REGRESSION_TOLERANCE must be in [0, 1): " + std::to_string(tolerance));
+        }
+        long long iterations_value = envNumber("REGRESSION_ITERATIONS", "5", parseInteger);
+        if (iterations_value < 1 || iterations_value > 1000) {
+            throw std::runtime_error("REGRESSION_ITERATIONS must be in [1, 1000]: "
+                                     + std::to_string(iterations_value));
+        }
+        iterations = static_cast<int>(iterations_value);
+        // Each tile is 170x170 pixels, so 64 tiles per side is already ~470 MB per image buffer
+        long long tiles_value = envNumber("REGRESSION_LARGE_TILES", "16", parseInteger);
+        if (tiles_value < 1 || tiles_value > 64) {
+            throw std::runtime_error("REGRESSION_LARGE_TILES must be in [1, 64]: " + std::to_string(tiles_value));
+        }
+        large_tiles = static_cast<uint32_t>(tiles_value);
+        update_baseline = envOr("REGRESSION_UPDATE_BASELINE", "0") != "0";
+        strict = envOr("REGRESSION_STRICT", "0") != "0";
+    }
+
+    static void TearDownTestSuite() {
+        baseline.reset();
+        halftoner.reset();
+        grayscaler.reset();
+        cropper.reset();
+        manager.reset();
+    }
+
+    static Image crop(const Image &input, uint32_t out_width, uint32_t out_height, uint32_t x, uint32_t y) {
+        return { cropper->process(input.pixels, input.width, input.height, out_width, out_height, x, y), out_width,
+                 out_height };
+    }
+
+    static Image grayscale(const Image &input) {
+        return { grayscaler->process(input.pixels, input.width, input.height, input.width, input.height),
+                 input.width, input.height };
+    }
+
+    static Image halftone(const Image &input) {
+        return { halftoner->process(input.pixels, input.width, input.height, input.width, input.height),
+                 input.width, input.height };
+    }
+
+    // Checks the first run against the golden image, then times the remaining runs and compares the
+    // best one against the stored baseline. Small images are dominated by launch overhead, so only
+    // cases with a budget are timed.
+    static void checkCase(const std::string &name, const std::function<Image()> &run, const Image &golden,
+                          bool timed) {
+        expectImagesEqual(run(), golden, name);
+        if (!timed || ::testing::Test::HasFailure()) {
+            return;
+        }
+
+        double best_seconds = 0.0;
+        for (int i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (i == 0 || elapsed.count() < best_seconds) {
+                best_seconds = elapsed.count();
+            }
+        }
+        double mpix_per_s = golden.pixels.size() / best_seconds / 1e6;
+        ::testing::Test::RecordProperty(name + "_mpix_per_s", std::to_string(mpix_per_s));
+
+        if (update_baseline) {
+            baseline->set(name, mpix_per_s);
+            return;
+        }
+
+        std::string missing;
+        if (!baseline->isLoaded()) {
+            missing = "no baseline file at " + baseline->getPath();
+        } else if (!baseline->matchesDevice()) {
+            missing = "baseline " + baseline->getPath() + " was recorded on '" + baseline->getStoredDevice()
+                      + "', not on this device";
+        } else if (!baseline->has(name)) {
+            missing = "no baseline for " + name + " in " + baseline->getPath();
+        }
+        if (!missing.empty()) {
+            missing += " (measured " + std::to_string(mpix_per_s)
+                       + " MP/s; record with REGRESSION_UPDATE_BASELINE=1)";
+            if (strict) {
+                FAIL() << missing;
+            }
+            GTEST_SKIP() << missing;
+        }
+        double expected = baseline->get(name);
+        EXPECT_GE(mpix_per_s, expected * (1.0 - tolerance))
+            << name << ": throughput dropped more than " << tolerance * 100.0 << "% below baseline of " << expected
+            << " MP/s";
+    }
+
+    static std::unique_ptr<OpenCLManager> manager;
+    static std::unique_ptr<CropProcessor> cropper;
+    static std::unique_ptr<GrayscaleProcessor> grayscaler;
+    static std::unique_ptr<HalftoneProcessor> halftoner;
+    static std::unique_ptr<ThroughputBaseline> baseline;
+    static double tolerance;
+    static int iterations;
+    static uint32_t large_tiles;
+    static bool update_baseline;
+    static bool strict;
+};
+
+std::unique_ptr<OpenCLManager> RegressionTest::manager;
+std::unique_ptr<CropProcessor> RegressionTest::cropper;
+std::unique_ptr<GrayscaleProcessor> RegressionTest::grayscaler;
+std::unique_ptr<HalftoneProcessor> RegressionTest::halftoner;
+std::unique_ptr<ThroughputBaseline> RegressionTest::baseline;
+double RegressionTest::tolerance;
+int RegressionTest::iterations;
+uint32_t RegressionTest::large_tiles;
+bool RegressionTest::update_baseline;
+bool RegressionTest::strict;
+
+TEST_F(RegressionTest, ResourcesCrop) {
+    Image input = loadImage("resources/input.png");
+    Image golden = loadImage("resources/cropped.png");
+    checkCase(
+        "resources_crop", [&] { return crop(input, kCropSize, kCropSize, kCropX, kCropY); }, golden, false);
+}
+
+TEST_F(RegressionTest, ResourcesGrayscale) {
+    Image input = loadImage("resources/cropped.png");
+    Image golden = loadImage("resources/grayed.png");
+    checkCase("resources_grayscale", [&] { return grayscale(input); }, golden, false);
+}
+
+TEST_F(RegressionTest, ResourcesHalftone) {
+    Image input = loadImage("resources/grayed.png");
+    Image golden = loadImage("resources/halftoned.png");
+    checkCase("resources_halftone", [&] { return halftone(input); }, golden, false);
+}
+
+TEST_F(RegressionTest, ResourcesPipeline) {
+    Image input = loadImage("resources/input.png");
+    Image golden = loadImage("resources/halftoned.png");
+    checkCase(
+        "resources_pipeline",
+        [&] { return halftone(grayscale(crop(input, kCropSize, kCropSize, kCropX, kCropY))); }, golden, false);
+}
+
+TEST_F(RegressionTest, LargeCrop) {
+    // Cropping one tile off the top-left of an (n+1)x(n+1) tiling leaves an nxn tiling
+    Image input = tileImage(loadImage("resources/cropped.png"), large_tiles + 1, large_tiles + 1);
+    Image golden = tileImage(loadImage("resources/cropped.png"), large_tiles, large_tiles);
+    checkCase(
+        "large_crop", [&] { return crop(input, golden.width, golden.height, kCropSize, kCropSize); }, golden, true);
+}
+
+TEST_F(RegressionTest, LargeGrayscale) {
+    Image input = tileImage(loadImage("resources/cropped.png"), large_tiles, large_tiles);
+    Image golden = tileImage(loadImage("resources/grayed.png"), large_tiles, large_tiles);
+    checkCase("large_grayscale", [&] { return grayscale(input); }, golden, true);
+}
+
+TEST_F(RegressionTest, LargeHalftone) {
+    Image input = tileImage(loadImage("resources/grayed.png"), large_tiles, large_tiles);
+    Image golden = tileImage(loadImage("resources/halftoned.png"), large_tiles, large_tiles);
+    checkCase("large_halftone", [&] { return halftone(input); }, golden, true);
+}
+
+TEST_F(RegressionTest, LargePipeline) {
+    Image input = tileImage(loadImage("resources/cropped.png"), large_tiles + 1, large_tiles + 1);
+    Image golden = tileImage(loadImage("resources/halftoned.png"), large_tiles, large_tiles);
+    checkCase(
+        "large_pipeline",
+        [&] { return halftone(grayscale(crop(input, golden.width, golden.height, kCropSize, kCropSize))); },
+        golden, true);
+}